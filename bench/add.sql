@@ -0,0 +1,4 @@
+-- intset_add: add one ID to a dense set through its side columns
+\set id random(1, :rows)
+\set x random(1, 1000000)
+UPDATE intset_dense SET adds = intset_add(adds, :x), removes = intset_remove(removes, :x) WHERE id = :id;
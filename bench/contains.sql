@@ -0,0 +1,4 @@
+-- <@ on a sparse set fetched by primary key
+\set id random(1, :rows)
+\set x random(1, 1000000)
+SELECT :x <@ s FROM intset_sparse WHERE id = :id;
@@ -0,0 +1,3 @@
+-- intset_in: parse a literal with a run and scattered values
+\set lo random(1, 1000000)
+SELECT ('{' || :lo || '-' || (:lo + 1000) || ',' || (:lo * 3) || ',' || (:lo * 5) || '}')::intset;
@@ -0,0 +1,3 @@
+-- primary key range scan returning 100 skewed sets and their cardinality
+\set id random(1, :rows - 100)
+SELECT id, @ s FROM intset_skewed WHERE id BETWEEN :id AND :id + 99;
@@ -0,0 +1,4 @@
+-- && between a sparse and a dense set
+\set a random(1, :rows)
+\set b random(1, :rows)
+SELECT x.s && y.s FROM intset_sparse x, intset_dense y WHERE x.id = :a AND y.id = :b;
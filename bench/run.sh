@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# Loads the synthetic tables and runs every pgbench script in bench/,
+# printing TPS and latency percentiles (ms) for each workload.
+#
+# Settings come from the environment:
+#   BENCH_DB (intset_bench)  BENCH_ROWS (10000)
+#   BENCH_TIME seconds (10)  BENCH_CLIENTS (4)
+#   PSQL, PGBENCH, CREATEDB  client programs to use
+#
+set -e
+
+DB=${BENCH_DB:-intset_bench}
+ROWS=${BENCH_ROWS:-10000}
+TIME=${BENCH_TIME:-10}
+CLIENTS=${BENCH_CLIENTS:-4}
+PSQL=${PSQL:-psql}
+PGBENCH=${PGBENCH:-pgbench}
+CREATEDB=${CREATEDB:-createdb}
+
+dir=$(dirname "$0")
+out="$dir/results"
+
+$CREATEDB "$DB" 2>/dev/null || true
+$PSQL -X -q -v ON_ERROR_STOP=1 -v rows="$ROWS" -d "$DB" -f "$dir/setup.sql"
+
+rm -rf "$out"
+mkdir -p "$out"
+
+printf '%-10s %10s %10s %10s %10s\n' workload tps p50_ms p95_ms p99_ms
+for w in in contains subset inters union indexscan add; do
+	$PGBENCH -n -f "$dir/$w.sql" -D rows="$ROWS" -c "$CLIENTS" -j "$CLIENTS" \
+		-T "$TIME" -l --log-prefix="$out/$w" "$DB" > "$out/$w.txt"
+	tps=$(sed -n 's/^tps = \([0-9.]*\).*/\1/p' "$out/$w.txt" | head -n 1)
+	# third column of the per-transaction log is the latency in microseconds
+	cat "$out/$w".[0-9]* | awk '{ print $3 }' | sort -n | \
+		awk -v w="$w" -v tps="$tps" '
+			{ lat[NR] = $1 }
+			function pct(p,  i) { i = int((NR * p + 99) / 100); if (i < 1) i = 1; return lat[i] / 1000 }
+			END { if (NR == 0) { printf "%-10s %10.1f %10s %10s %10s\n", w, tps, "-", "-", "-"; exit }
+			      printf "%-10s %10.1f %10.3f %10.3f %10.3f\n", w, tps, pct(50), pct(95), pct(99) }'
+done
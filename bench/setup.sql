@@ -0,0 +1,38 @@
+--
+-- Synthetic tables for the intset pgbench workloads.
+-- Run by bench/run.sh with -v rows=N.
+--
+SET client_min_messages = warning;
+CREATE EXTENSION IF NOT EXISTS intset;
+
+DROP TABLE IF EXISTS intset_sparse, intset_dense, intset_skewed;
+
+-- 100 scattered integers per row, almost no runs
+CREATE TABLE intset_sparse AS
+SELECT g AS id,
+       (SELECT ('{' || string_agg((random() * 1000000)::int::text, ',') || '}')::intset
+          FROM generate_series(1, 100) WHERE g > 0) AS s
+  FROM generate_series(1, :rows) g;
+
+-- 10 long runs per row, the ID-block case
+CREATE TABLE intset_dense AS
+SELECT g AS id,
+       (SELECT ('{' || string_agg(lo || '-' || (lo + 1000 + (random() * 10000)::int), ',') || '}')::intset
+          FROM (SELECT (random() * 1000000)::int AS lo
+                  FROM generate_series(1, 10) WHERE g > 0) r) AS s
+  FROM generate_series(1, :rows) g;
+
+-- mostly tiny sets with a long tail of large ones (up to 10000 elements)
+CREATE TABLE intset_skewed AS
+SELECT g AS id,
+       (SELECT ('{' || string_agg((random() * 1000000)::int::text, ',') || '}')::intset
+          FROM generate_series(1, least(10000, (1.0 / (random() + 0.0001))::int)) WHERE g > 0) AS s
+  FROM generate_series(1, :rows) g;
+
+-- changes to the dense sets go to small side columns, see bench/add.sql
+ALTER TABLE intset_dense ADD adds intset DEFAULT '{}', ADD removes intset DEFAULT '{}';
+
+ALTER TABLE intset_sparse ADD PRIMARY KEY (id);
+ALTER TABLE intset_dense ADD PRIMARY KEY (id);
+ALTER TABLE intset_skewed ADD PRIMARY KEY (id);
+ANALYZE intset_sparse, intset_dense, intset_skewed;
@@ -0,0 +1,4 @@
+-- || between a skewed and a dense set
+\set a random(1, :rows)
+\set b random(1, :rows)
+SELECT x.s || y.s FROM intset_skewed x, intset_dense y WHERE x.id = :a AND y.id = :b;
@@ -6,10 +6,19 @@
   called by the backend in the process of processing queries.  The calling
   format for these routines is dictated by Postgres architecture.
 
-
-  Implementation could be optimized through an index wrapper of each individual
-  integer. This would allow binary search when calling functions.
-  The file is not incredibly optimized as it was a learning excercise for the 
+  Internally an intset is stored as its canonical text form, a sorted list of
+  runs of consecutive integers, e.g. '{1-1000,2000}'. A run of three or more
+  integers is written 'lo-hi', so a set of 1..1,000,000 takes constant space.
+  The operators walk the runs of both inputs side by side and never expand
+  them into individual integers.
+
+  A large set that changes often is best kept as three columns: the set
+  itself and two small sets of added and removed integers. intset_add and
+  intset_remove update the small columns, intset_apply reads the current
+  set and intset_compact (intset.source) folds the changes back in. An
+  UPDATE that leaves the large column alone keeps its TOAST value as is.
+
+  The file is not incredibly optimized as it was a learning excercise for the
   backend of postgreSQL.
 
   Created by Leo Hoare and Isabelle Lou
@@ -17,7 +26,14 @@
 
 #include "postgres.h"
 #include "fmgr.h"
+#include "funcapi.h"
+#include "access/htup_details.h"
+#include "lib/stringinfo.h"
 #include "libpq/pqformat.h"		/* needed for send/recv functions */
+#include "portability/instr_time.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/memutils.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -28,7 +44,7 @@ PG_MODULE_MAGIC;
 
 #define MAXDIGITSIZE 19
 
-// structure of varlena defined here 
+// structure of varlena defined here
 // could also just define intset as varlena....
 // typedef struct varlena intset
 typedef struct intset
@@ -38,12 +54,154 @@ typedef struct intset
 	char vl_dat[FLEXIBLE_ARRAY_MEMBER];
 } intset;
 
+// a run of consecutive integers lo..hi (inclusive)
+// int64 so that hi + 1 never overflows at the edge of int32
+typedef struct intset_run
+{
+	int64 lo;
+	int64 hi;
+} intset_run;
+
+// cursor over the runs stored in an intset
+typedef struct run_reader
+{
+	const char *pos;
+	const char *end;
+} run_reader;
+
+// builds the canonical text of an intset from runs given in ascending order
+// of their lower bound, merging runs that overlap or touch
+typedef struct run_writer
+{
+	StringInfoData buf;
+	int32 hdr;				// bytes reserved for the varlena header, 0 for a cstring
+	bool pending;
+	int64 lo;
+	int64 hi;
+} run_writer;
+
+// set operations handled by run_merge
+#define INTSET_UNION	0
+#define INTSET_INTERS	1
+#define INTSET_DIF		2
+#define INTSET_DISJ		3
+
+
+/*****************************************************************************
+ * Backend-local statistics
+  Off unless intset.track_stats is set. Each SQL-callable function owns a
+  slot of counters, read back with intset_stats() and cleared with
+  intset_stats_reset(). The helpers add to the pending counters below and
+  stats_end moves them into the slot of the function that is running.
+  bytes_palloc is how much the memory context of the call grew, counted in
+  whole blocks, so it is approximate: small allocations that fit in a block
+  already held add nothing, and one that needs a new block adds all of it.
+ *****************************************************************************/
+
+enum
+{
+	INTSET_STAT_IN,
+	INTSET_STAT_OUT,
+	INTSET_STAT_RANGE,
+	INTSET_STAT_CARD,
+	INTSET_STAT_CONTAINS,
+	INTSET_STAT_SUBSET,
+	INTSET_STAT_EQUAL,
+	INTSET_STAT_NOT_EQUAL,
+	INTSET_STAT_UNION,
+	INTSET_STAT_INTERS,
+	INTSET_STAT_DIF,
+	INTSET_STAT_DISJ,
+	INTSET_STAT_ADD,
+	INTSET_STAT_REMOVE,
+	INTSET_STAT_APPLY,
+	INTSET_NSTATS
+};
+
+static const char *const intset_stat_names[INTSET_NSTATS] = {
+	"intset_in", "intset_out", "intset_range", "intset_card",
+	"intset_contains", "intset_subset", "intset_equal", "intset_not_equal",
+	"intset_union", "intset_inters", "intset_dif", "intset_disj",
+	"intset_add", "intset_remove", "intset_apply"
+};
+
+typedef struct intset_counters
+{
+	int64 calls;
+	int64 runs;				// run tokens parsed or read
+	int64 bytes_detoasted;
+	int64 bytes_palloc;		// growth of CurrentMemoryContext, see above
+	instr_time time;
+} intset_counters;
+
+static bool intset_track_stats = false;
+static intset_counters intset_stats_data[INTSET_NSTATS];
+static int64 pending_runs = 0, pending_detoasted = 0, palloc_start = 0;
+static MemoryContext stats_context = NULL;
+
+// adds to a pending counter only while tracking, so the hot loops stay cheap
+#define STATS_ADD(counter, n) do { if (intset_track_stats) { (counter) += (n); } } while (0)
+
+void _PG_init(void);
+
+void
+_PG_init(void)
+{
+	DefineCustomBoolVariable("intset.track_stats",
+							 "Collects per-backend call counts and timings for intset functions.",
+							 NULL,
+							 &intset_track_stats,
+							 false,
+							 PGC_USERSET,
+							 0,
+							 NULL, NULL, NULL);
+#if PG_VERSION_NUM >= 150000
+	MarkGUCPrefixReserved("intset");
+#else
+	EmitWarningsOnPlaceholders("intset");
+#endif
+}
+
+static void stats_begin(instr_time *start){
+        if (!intset_track_stats) { return; }
+        pending_runs = pending_detoasted = 0;
+        stats_context = CurrentMemoryContext;
+        palloc_start = MemoryContextMemAllocated(stats_context, false);
+        INSTR_TIME_SET_CURRENT(*start);
+}
+
+static void stats_end(int slot, instr_time *start){
+        intset_counters *c = &intset_stats_data[slot];
+        instr_time now;
+        if (!intset_track_stats) { return; }
+        INSTR_TIME_SET_CURRENT(now);
+        INSTR_TIME_ACCUM_DIFF(c->time, now, *start);
+        c->calls++;
+        c->runs += pending_runs;
+        c->bytes_detoasted += pending_detoasted;
+        c->bytes_palloc += MemoryContextMemAllocated(stats_context, false) - palloc_start;
+}
+
+// PG_GETARG_VARLENA_P that also counts the bytes detoasted
+// only out-of-line or compressed values count, copying a short header
+// value to a 4-byte header is not detoasting
+#define INTSET_GETARG_P(n) intset_getarg(fcinfo, (n))
+
+static intset *intset_getarg(FunctionCallInfo fcinfo, int n){
+        struct varlena *d = (struct varlena *) DatumGetPointer(PG_GETARG_DATUM(n));
+        struct varlena *p = PG_DETOAST_DATUM(PointerGetDatum(d));
+        if (VARATT_IS_EXTERNAL(d) || VARATT_IS_COMPRESSED(d)) {
+                STATS_ADD(pending_detoasted, VARSIZE(p));
+        }
+        return (intset *) p;
+}
+
 // converts a set to cstring for operations
 // make sure to free cstring after use
- 
+
 static char * intset_to_cstring(const intset *i)
  {
-     int         len = VARSIZE(i)-VARHDRSZ;
+     int         len = VARSIZE_ANY_EXHDR(i);
      char       *result;
      result = (char *) palloc(len + 1);
      memcpy(result, VARDATA_ANY(i), len);
@@ -54,207 +212,229 @@ static char * intset_to_cstring(const intset *i)
 // function to remove trailing and leading white space from tokens (or Cstrings).
 static char *remove_space(char *str)
 {
-  char *end; 
+  char *end;
   while(isspace((unsigned char)*str)) str++;
   if(*str == 0)
     return str;
   end = str + strlen(str) - 1;
-  while(end > str && isspace((unsigned char)*end)) end--; 
+  while(end > str && isspace((unsigned char)*end)) end--;
   end[1] = '\0';
   return str;
 }
 // Quoted from https://stackoverflow.com/questions/122616/how-do-i-trim-leading-trailing-whitespace-in-a-standard-way
 
-// Function finds the index of a character array in 
-// used for insertion in intset data structure
-// -2 means it is found the integer within the set 
-// -1 means no number is greater than the new number 
-// else if index > 0 it is the index of the comma before the number
-static int find_index(intset *set, char *cstr){
-	int32 num1= atol(cstr),num2,i=0,j=0,final_index=-1;
-	char buffer[MAXDIGITSIZE]; 
-	memset(buffer,'\0',MAXDIGITSIZE);
-	for (i=0;i<(VARSIZE(set)-VARHDRSZ)+1;i++){
-		if (i<VARSIZE(set)-VARHDRSZ && VARDATA(set)[i] != ',') {
-			buffer[j] = VARDATA(set)[i];
-			j++;
-		}
-		else{
-			num2 = atol(buffer);
-			if (num1 < num2) {
-				final_index = i-j;
-				return final_index;
-			}
-			else if (num1 == num2 ) {
-				final_index = -2; 
-				return final_index;
-			}
-			memset(buffer,'\0',MAXDIGITSIZE);		
-			j=0;
-		}
-	}
-	return final_index;
-}
-
-
-// function to concat the strings in ascending order
-// and adds the comma between them
-static intset *concat_inorder(intset *set, char *add){
-    int32 index = find_index(set, add);
-	int32 new_size;
-	intset *new_intset;
-	char *coma = ",";
-	if (index >= -1){
-		new_size = VARSIZE(set) + strlen(add) + 1;
-        new_intset = (intset*)palloc(new_size); 	
-		SET_VARSIZE(new_intset, new_size);
-		if (index == -1){ // case for inserting at end
-        		memcpy(VARDATA(new_intset), VARDATA(set), VARSIZE(set)-VARHDRSZ);
-        		memcpy(VARDATA(new_intset)+VARSIZE(set)-VARHDRSZ, coma, 1); 
-        		memcpy(VARDATA(new_intset)+VARSIZE(set)-VARHDRSZ+1, add, strlen(add));    
-		}
-		else { // case for insertion at index 
-			memcpy(VARDATA(new_intset),VARDATA(set),index);
-                        memcpy(VARDATA(new_intset)+index, add, strlen(add));
-                        memcpy(VARDATA(new_intset)+index+strlen(add), coma, 1); 
-                        memcpy(VARDATA(new_intset)+index+strlen(add)+1,VARDATA(set)+index,VARSIZE(set)-VARHDRSZ-index);
-		}
-		
-		return new_intset;
-	}
-	else {return set;}	
+
+/*****************************************************************************
+ * Run reader
+  Stored sets are always well formed (written by intset_in or run_writer),
+  so the reader does not validate. Sets stored before ranges existed are
+  plain comma lists such as '{1,2,3}'; adjacent tokens are merged on the fly
+  so every caller sees maximal runs whatever the stored spelling.
+ *****************************************************************************/
+
+static void reader_init(run_reader *r, const intset *set){
+        r->pos = VARDATA_ANY(set);
+        r->end = r->pos + VARSIZE_ANY_EXHDR(set);
+        if (r->pos < r->end && *r->pos == '{') { r->pos++; }
+        if (r->end > r->pos && r->end[-1] == '}') { r->end--; }
 }
 
-// function to add brackets to intset
+static int64 read_number(run_reader *r){
+        int64 val = 0;
+        bool neg = false;
+        if (r->pos < r->end && *r->pos == '-') { neg = true; r->pos++; }
+        while (r->pos < r->end && isdigit((unsigned char)*r->pos)){
+                val = val * 10 + (*r->pos - '0');
+                r->pos++;
+        }
+        return neg ? -val : val;
+}
 
-static intset * add_brackets(intset *set){
-	int32 new_size = VARSIZE(set)+2;
-	intset *new_intset = (intset*)palloc(new_size);
-	char *open = "{", *close = "}";
-	SET_VARSIZE(new_intset, new_size);
-	memcpy(VARDATA(new_intset),open,1);
-	memcpy(VARDATA(new_intset)+1,VARDATA(set),VARSIZE(set)-VARHDRSZ);
-	memcpy(VARDATA(new_intset)+VARSIZE(set)-VARHDRSZ+1,close,1);
-	return new_intset;
+// reads a single 'n' or 'lo-hi' token, returns false at the end of the set
+static bool read_token(run_reader *r, intset_run *run){
+        if (r->pos >= r->end) { return false; }
+        run->lo = read_number(r);
+        run->hi = run->lo;
+        if (r->pos < r->end && *r->pos == '-') {
+                r->pos++;
+                run->hi = read_number(r);
+        }
+        if (r->pos < r->end && *r->pos == ',') { r->pos++; }
+        return true;
 }
 
-// function to remove brackets from intset
+// reads the next maximal run, returns false at the end of the set
+static bool next_run(run_reader *r, intset_run *run){
+        const char *save;
+        intset_run next;
+        if (!read_token(r, run)) { return false; }
+        STATS_ADD(pending_runs, 1);
+        for (;;){
+                save = r->pos;
+                if (!read_token(r, &next) || next.lo > run->hi + 1) { r->pos = save; break; }
+                if (next.hi > run->hi) { run->hi = next.hi; }
+                STATS_ADD(pending_runs, 1);
+        }
+        return true;
+}
 
-static intset * take_brackets(intset *set){
-        int32 new_size = VARSIZE(set)-2;
-        intset *new_intset = (intset*)palloc(new_size);
-        SET_VARSIZE(new_intset, new_size);
-        memcpy(VARDATA(new_intset),VARDATA(set)+1,VARSIZE(set)-VARHDRSZ-1);
-        return new_intset;
+// true if the set has no elements
+static bool is_empty(const intset *set){
+        run_reader r;
+        reader_init(&r, set);
+        return r.pos >= r.end;
 }
 
 
-// function to assign new intset given a character array
+/*****************************************************************************
+ * Run writer
+ *****************************************************************************/
 
-static intset* new_intset(intset * set, char *tok){
-        set = (intset*)palloc(VARHDRSZ + strlen(tok));
-        SET_VARSIZE(set,VARHDRSZ + strlen(tok)); 
-        memcpy(VARDATA(set),tok,strlen(tok));
-        return set;
+// as_intset leaves room for the varlena header, see writer_finish_intset
+// otherwise the buffer is a plain cstring, see writer_finish
+static void writer_init(run_writer *w, bool as_intset){
+        initStringInfo(&w->buf);
+        w->hdr = as_intset ? VARHDRSZ : 0;
+        if (as_intset) { appendStringInfoSpaces(&w->buf, VARHDRSZ); }
+        appendStringInfoChar(&w->buf, '{');
+        w->pending = false;
 }
 
-// function to concat to end of character array
+// appends the pending run to the text, pairs are written as 'lo,hi'
+static void writer_flush(run_writer *w){
+        if (!w->pending) { return; }
+        if (w->buf.len > w->hdr + 1) { appendStringInfoChar(&w->buf, ','); }
+        if (w->lo == w->hi) {
+                appendStringInfo(&w->buf, "%d", (int32) w->lo);
+        }
+        else if (w->hi == w->lo + 1) {
+                appendStringInfo(&w->buf, "%d,%d", (int32) w->lo, (int32) w->hi);
+        }
+        else {
+                appendStringInfo(&w->buf, "%d-%d", (int32) w->lo, (int32) w->hi);
+        }
+        w->pending = false;
+}
 
-static intset *concat_intset(intset *set, char *add){
-        int32 new_size = VARSIZE(set) + strlen(add) + 1;
-        intset *new_intset = (intset*)palloc(new_size);
-        char *coma = ",";
-        SET_VARSIZE(new_intset, new_size);
-        memcpy(VARDATA(new_intset), VARDATA(set), VARSIZE(set)-VARHDRSZ);
-        memcpy(VARDATA(new_intset)+VARSIZE(set)-VARHDRSZ, coma, 1); 
-        memcpy(VARDATA(new_intset)+VARSIZE(set)-VARHDRSZ+1, add, strlen(add));
-        return new_intset;
+static void writer_add(run_writer *w, int64 lo, int64 hi){
+        if (w->pending && lo <= w->hi + 1) {
+                if (hi > w->hi) { w->hi = hi; }
+                return;
+        }
+        writer_flush(w);
+        w->lo = lo;
+        w->hi = hi;
+        w->pending = true;
 }
 
+static void writer_close(run_writer *w){
+        writer_flush(w);
+        appendStringInfoChar(&w->buf, '}');
+}
 
-// helper function to determine if the intset contains a number
+// finishes the set and returns its text, e.g. '{1-1000,2000}'
+// the text is the palloc'd buffer itself, so callers may pfree it
+static char *writer_finish(run_writer *w){
+        Assert(w->hdr == 0);
+        writer_close(w);
+        return w->buf.data;
+}
 
-static int does_contain(int32 num1, intset *set, int32 index){
-        int32 num2,i=0,j=0;
-        char buffer[MAXDIGITSIZE];
-        memset(buffer,'\0',MAXDIGITSIZE);
-        if( VARDATA(set)[1] == '}' ){ // empty set
-                return 0;
-        }
-        for (i=index;i<(VARSIZE(set)-VARHDRSZ);i++){
-                if (i<VARSIZE(set)-VARHDRSZ-1 && VARDATA(set)[i] != ',') {
-                        buffer[j] = VARDATA(set)[i];
-                        j++;
-                }
-                else{
-                        // sets up new index (assumes always correctly formatted...)
-                        num2 = atol(buffer);
-                        if (num1 < num2 ){
-                                return 0;
-                        }
-                        if (num1 == num2 ) {
-                                return i;
-                        }
-                        memset(buffer,'\0',MAXDIGITSIZE);
-                        j=0;
-                }
-        }
-        return 0;
+// finishes the set and returns it as an intset, built in place
+static intset *writer_finish_intset(run_writer *w){
+        Assert(w->hdr == VARHDRSZ);
+        writer_close(w);
+        SET_VARSIZE(w->buf.data, w->buf.len);
+        return (intset *) w->buf.data;
 }
 
 
+/*
+  Core of the set operators.
+  Sweeps both run lists left to right, splitting the number line at every run
+  boundary. Between two boundaries membership in each set is constant, so the
+  whole stretch is kept or dropped at once. Cost is linear in the number of
+  runs, not the number of elements.
+*/
 
-// helper function checks if all characters are the same in two intsets
-static int does_equals(intset *set1, intset *set2){
-        int32 len1 = VARSIZE(set1), len2= VARSIZE(set2), i;
-        if (len1 != len2) { return 0; }
-        else {
-                for (i=1;i<len1-VARHDRSZ;i++){
-                        if (VARDATA(set1)[i] != VARDATA(set2)[i]) {return 0;}
+static char *run_merge(intset *set1, intset *set2, int op){
+        run_reader r1, r2;
+        run_writer w;
+        intset_run a, b;
+        bool has_a, has_b, in_a, in_b, keep;
+        int64 cur, end;
+
+        reader_init(&r1, set1);
+        reader_init(&r2, set2);
+        writer_init(&w, false);
+        has_a = next_run(&r1, &a);
+        has_b = next_run(&r2, &b);
+        if (!has_a && !has_b) { return writer_finish(&w); }
+        if (!has_a) { cur = b.lo; }
+        else if (!has_b) { cur = a.lo; }
+        else { cur = a.lo < b.lo ? a.lo : b.lo; }
+
+        while (has_a || has_b){
+                // nothing left that could be kept
+                if (op == INTSET_INTERS && (!has_a || !has_b)) { break; }
+                if (op == INTSET_DIF && !has_a) { break; }
+
+                in_a = has_a && a.lo <= cur;
+                in_b = has_b && b.lo <= cur;
+                // end of the stretch that starts at cur with constant membership
+                end = PG_INT64_MAX;
+                if (has_a) { end = in_a ? a.hi : a.lo - 1; }
+                if (has_b) {
+                        int64 e = in_b ? b.hi : b.lo - 1;
+                        if (e < end) { end = e; }
                 }
+
+                switch (op){
+                        case INTSET_UNION:  keep = in_a || in_b; break;
+                        case INTSET_INTERS: keep = in_a && in_b; break;
+                        case INTSET_DIF:    keep = in_a && !in_b; break;
+                        default:            keep = in_a != in_b; break;
+                }
+                if (keep) { writer_add(&w, cur, end); }
+
+                cur = end + 1;
+                if (has_a && a.hi < cur) { has_a = next_run(&r1, &a); }
+                if (has_b && b.hi < cur) { has_b = next_run(&r2, &b); }
         }
-        return 1;
+        return writer_finish(&w);
 }
 
 
-// helper function used for set difference and set disjunction
-// produces a new intset which is the difference of set 1 - set 2
-static intset *set_dif(intset *set1, intset *set2){
-        intset *new_set=(intset*)palloc(VARHDRSZ);
-        int32 i,j=0,current_index=1,new_index=0,loop_indicator=0;
-        char buffer[MAXDIGITSIZE];
-        // set new_set as empty
-        SET_VARSIZE(new_set,VARHDRSZ);
-        // cases for empty set
-        if (VARDATA(set1)[1] == '}' || VARDATA(set2)[1] == '}'){
-                return set1;
+// sorts parsed runs by their lower bound
+static int run_cmp(const void *x, const void *y){
+        const intset_run *a = (const intset_run *) x, *b = (const intset_run *) y;
+        if (a->lo < b->lo) { return -1; }
+        if (a->lo > b->lo) { return 1; }
+        return 0;
+}
+
+// parses one integer of an input token, p is left just after its last digit
+static int64 parse_bound(char **p, const char *tok){
+        char *start = *p, *digits;
+        int64 val = 0;
+        if (**p == '-') { (*p)++; }
+        digits = *p;
+        while (isdigit((unsigned char)**p)) { (*p)++; }
+        if (*p == digits) {
+                ereport(ERROR,(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),errmsg("CASE INVALID CHARACTERS IN STRING '%s' '%c'",tok,**p ? **p : ' ')));
         }
-        // otherwise start checking ints
-        memset(buffer,'\0',MAXDIGITSIZE);
-        for (i=1;i<VARSIZE(set1)-VARHDRSZ;i++){
-                if (i<VARSIZE(set1)-VARHDRSZ-1 && VARDATA(set1)[i] !=','){
-                        buffer[j]=VARDATA(set1)[i];
-                        j++;
-                }
-                else {
-                        new_index = does_contain(atol(buffer),set2,current_index);
-                        if ( new_index != 0) { current_index = new_index; }
-                        else {
-                                // x doesn't contains the number
-                                // concat to end of string
-                                if ( loop_indicator == 0 ) { new_set = new_intset(new_set,buffer); loop_indicator++;}
-                                else { new_set = concat_intset(new_set,buffer); }
-                        }
-                        memset(buffer,'\0',MAXDIGITSIZE);
-                        j=0;
-                }
+        if (*p - digits >= MAXDIGITSIZE) {
+                ereport(ERROR,(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),errmsg("INTEGER TOO BIG, MUST BE LESS THAN %d",MAXDIGITSIZE)));
         }
-        new_set = add_brackets(new_set);
-        return new_set;
+        for (; digits < *p; digits++) { val = val * 10 + (*digits - '0'); }
+        if (*start == '-') { val = -val; }
+        if (val < PG_INT32_MIN || val > PG_INT32_MAX) {
+                ereport(ERROR,(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),errmsg("INTEGER OUT OF RANGE '%s'",tok)));
+        }
+        return val;
 }
 
 
-
 /**********************************************************************
  * Input/Output functions
  *****************************************************************************/
@@ -266,11 +446,11 @@ static intset *set_dif(intset *set1, intset *set2){
   The function checks for correct input, raising errors and not inserting if incorrect
   Implementing using Strtok and iterating based on coma seperated strings.
   An example of a correct input '{1,2,3,4,5}'
+  A range of consecutive integers may be given as 'lo-hi', e.g. '{1-1000,2000}'
   The data type only accepts, white spaces (removed), '-', ',' or digits.
   MAXDIGITSIZE set to 19 as default.
-  Due to the variable being 'TOASTED' and excess data being stored on overflow pages
-  The variable supports large digit sizes.
-  However, could be more efficient dealing with high cardinality (20,000+)
+  Tokens are collected as runs, sorted and merged, so the input may be in any
+  order and may overlap. The stored text is always the canonical form.
 */
 
 PG_FUNCTION_INFO_V1(intset_in);
@@ -278,46 +458,54 @@ PG_FUNCTION_INFO_V1(intset_in);
 Datum
 intset_in(PG_FUNCTION_ARGS)
 {
-	/* inserts into BST and then takes output string and stores in similar type to varlena */
-	char *input1 = PG_GETARG_CSTRING(0);
+	char *input;
+	char *tok = NULL, *rest, *p, *nobrackets;
+	int32 nruns = 0, maxruns = 16, i;
+	intset_run *runs;
 	intset *result;
-	char *input = remove_space(input1);
-	char *tok = NULL,*rest, *nobrackets = (char*)palloc(strlen(input)-1);
-	int i, loop_indicator=0;	
-	result = (intset*)palloc(VARHDRSZ);
-	SET_VARSIZE(result,VARHDRSZ);
+	run_writer w;
+	instr_time start;
+	stats_begin(&start);
+	input = remove_space(PG_GETARG_CSTRING(0));
 	// remove brackets at position 1 or zero or cast error (implement later)
-	if (input[0] != '{' || input[strlen(input)-1] != '}'){ ereport(ERROR, (errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),errmsg("CASE ERROR BRACKETS MUST BE START & END")));}
-	else {strncpy(nobrackets,input+1,strlen(input)-2); nobrackets[strlen(input)-2] ='\0'; }
+	if (strlen(input) < 2 || input[0] != '{' || input[strlen(input)-1] != '}'){ ereport(ERROR, (errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),errmsg("CASE ERROR BRACKETS MUST BE START & END")));}
+	nobrackets = pnstrdup(input+1, strlen(input)-2);
 
-	rest = input;
+	runs = (intset_run*)palloc(maxruns * sizeof(intset_run));
 	tok = strtok_r(nobrackets, ",", &rest);
 	while ( tok != NULL){
-		tok = remove_space(tok);	
+		tok = remove_space(tok);
 		if (strlen(tok) != 0){
-			for (i = 0; i < strlen(tok); i++){
-				if (!isdigit(tok[i]) && !(tok[i] == '-' && i == 0)) {
-					ereport(ERROR,(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),errmsg("CASE INVALID CHARACTERS IN STRING '%s' '%c'",tok,tok[i])));
-				}
-			}	
-			if (strlen(tok) >= MAXDIGITSIZE) {
-				ereport(ERROR,(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),errmsg("INTEGER TOO BIG, MUST BE LESS THAN %d",MAXDIGITSIZE)));
+			if (nruns == maxruns){
+				maxruns *= 2;
+				runs = (intset_run*)repalloc(runs, maxruns * sizeof(intset_run));
 			}
-			if (loop_indicator == 0){
-				// make new intset
-				result = (intset*)palloc(VARHDRSZ + strlen(tok)); //sizeof(int)
-				SET_VARSIZE(result,VARHDRSZ + strlen(tok)); //sizeof(int)
-				memcpy(VARDATA(result),tok,strlen(tok));
-				loop_indicator++;
+			p = tok;
+			runs[nruns].lo = parse_bound(&p, tok);
+			runs[nruns].hi = runs[nruns].lo;
+			while (isspace((unsigned char)*p)) p++;
+			if (*p == '-'){
+				p++;
+				while (isspace((unsigned char)*p)) p++;
+				runs[nruns].hi = parse_bound(&p, tok);
+				if (runs[nruns].hi < runs[nruns].lo){
+					ereport(ERROR,(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),errmsg("CASE INVALID RANGE '%s', LOWER BOUND MUST NOT EXCEED UPPER",tok)));
+				}
 			}
-			else {
-				// concat current intset.
-				result = concat_inorder(result,tok);
+			if (*p != '\0') {
+				ereport(ERROR,(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),errmsg("CASE INVALID CHARACTERS IN STRING '%s' '%c'",tok,*p)));
 			}
+			nruns++;
+			STATS_ADD(pending_runs, 1);
 		}
 		tok = strtok_r(NULL,",",&rest);
 	}
-	result = add_brackets(result);
+
+	qsort(runs, nruns, sizeof(intset_run), run_cmp);
+	writer_init(&w, true);
+	for (i = 0; i < nruns; i++){ writer_add(&w, runs[i].lo, runs[i].hi); }
+	result = writer_finish_intset(&w);
+	stats_end(INTSET_STAT_IN, &start);
 	PG_RETURN_POINTER(result);
 }
 
@@ -332,25 +520,169 @@ PG_FUNCTION_INFO_V1(intset_out);
 
 Datum
 intset_out(PG_FUNCTION_ARGS)
-{	
-	intset *out = (intset*)PG_GETARG_VARLENA_P(0);
-	char *result = intset_to_cstring(out);
+{
+	char *result;
+	instr_time start;
+	stats_begin(&start);
+	result = intset_to_cstring(INTSET_GETARG_P(0));
+	stats_end(INTSET_STAT_OUT, &start);
 	PG_RETURN_CSTRING(result);
 }
 
 
+/*
+  Range constructor
+  Returns the intset of every integer from lo to hi inclusive, stored as
+  a single run. An empty set is returned if lo is greater than hi.
+*/
+
+PG_FUNCTION_INFO_V1(intset_range);
+
+Datum
+intset_range(PG_FUNCTION_ARGS)
+{
+	int32 lo = PG_GETARG_INT32(0);
+	int32 hi = PG_GETARG_INT32(1);
+	intset *result;
+	run_writer w;
+	instr_time start;
+	stats_begin(&start);
+	writer_init(&w, true);
+	if (lo <= hi){ writer_add(&w, lo, hi); }
+	result = writer_finish_intset(&w);
+	stats_end(INTSET_STAT_RANGE, &start);
+	PG_RETURN_POINTER(result);
+}
+
+
+// copies the runs of a set with num added or removed, in a single pass
+static intset *with_member(intset *set, int64 num, bool add){
+        run_reader r;
+        run_writer w;
+        intset_run run;
+        bool done = !add;
+        reader_init(&r, set);
+        writer_init(&w, true);
+        while (next_run(&r, &run)){
+                if (!done && num <= run.hi) {
+                        if (num < run.lo) { writer_add(&w, num, num); }
+                        done = true;
+                }
+                if (!add && num >= run.lo && num <= run.hi) {
+                        if (run.lo < num) { writer_add(&w, run.lo, num - 1); }
+                        if (num < run.hi) { writer_add(&w, num + 1, run.hi); }
+                        continue;
+                }
+                writer_add(&w, run.lo, run.hi);
+        }
+        if (!done) { writer_add(&w, num, num); }
+        return writer_finish_intset(&w);
+}
+
+/*
+  Add and remove a single integer
+  Each call copies the whole set, so a large set that changes often should
+  keep its changes in two small columns instead, see intset_apply:
+    UPDATE t SET adds = intset_add(adds, n), removes = intset_remove(removes, n)
+  Returns the updated intset.
+*/
+
+PG_FUNCTION_INFO_V1(intset_add);
+
+Datum
+intset_add(PG_FUNCTION_ARGS)
+{
+	intset *result;
+	instr_time start;
+	stats_begin(&start);
+	result = with_member(INTSET_GETARG_P(0), PG_GETARG_INT32(1), true);
+	stats_end(INTSET_STAT_ADD, &start);
+	PG_RETURN_POINTER(result);
+}
+
+PG_FUNCTION_INFO_V1(intset_remove);
+
+Datum
+intset_remove(PG_FUNCTION_ARGS)
+{
+	intset *result;
+	instr_time start;
+	stats_begin(&start);
+	result = with_member(INTSET_GETARG_P(0), PG_GETARG_INT32(1), false);
+	stats_end(INTSET_STAT_REMOVE, &start);
+	PG_RETURN_POINTER(result);
+}
+
+/*
+  Apply changes kept beside a set
+  Returns (base - removes) || adds, built in one sweep over the three inputs
+  the same way run_merge does for two. When there are no changes the base
+  is returned as it came, without being detoasted or copied.
+*/
+
+PG_FUNCTION_INFO_V1(intset_apply);
+
+Datum
+intset_apply(PG_FUNCTION_ARGS)
+{
+	intset *adds, *removes;
+	run_reader r[3];
+	intset_run run[3];
+	bool has[3], in[3];
+	run_writer w;
+	int64 cur, end, e;
+	int i;
+	Datum result;
+	instr_time start;
+	stats_begin(&start);
+	adds = INTSET_GETARG_P(1);
+	removes = INTSET_GETARG_P(2);
+	if (is_empty(adds) && is_empty(removes)) {
+		result = PG_GETARG_DATUM(0);
+		stats_end(INTSET_STAT_APPLY, &start);
+		PG_RETURN_DATUM(result);
+	}
+	// 0 is the base, 1 the added and 2 the removed integers
+	reader_init(&r[0], INTSET_GETARG_P(0));
+	reader_init(&r[1], adds);
+	reader_init(&r[2], removes);
+	writer_init(&w, true);
+	cur = PG_INT64_MAX;
+	for (i = 0; i < 3; i++){
+		has[i] = next_run(&r[i], &run[i]);
+		if (has[i] && run[i].lo < cur) { cur = run[i].lo; }
+	}
+	while (has[0] || has[1]){
+		end = PG_INT64_MAX;
+		for (i = 0; i < 3; i++){
+			in[i] = has[i] && run[i].lo <= cur;
+			if (has[i]) {
+				e = in[i] ? run[i].hi : run[i].lo - 1;
+				if (e < end) { end = e; }
+			}
+		}
+		if ((in[0] && !in[2]) || in[1]) { writer_add(&w, cur, end); }
+		cur = end + 1;
+		for (i = 0; i < 3; i++){
+			if (has[i] && run[i].hi < cur) { has[i] = next_run(&r[i], &run[i]); }
+		}
+	}
+	result = PointerGetDatum(writer_finish_intset(&w));
+	stats_end(INTSET_STAT_APPLY, &start);
+	PG_RETURN_DATUM(result);
+}
+
+
 /*****************************************************************************
  * New Operators
-  Operators could be made more efficient with implementation of data structures 
-  and indexing structure wrapper on the intset data type.
-  The time complexity of each structure could also further be improved
+  Every operator works on runs, so its cost depends on how many runs the
+  sets have rather than how many integers they hold.
  *****************************************************************************/
 
 
 /*
   Cardinality function
-  Could be made much more efficient with indexing
-  Simply return the amount of indexs.
+  Sums the length of every run.
   Returns an integer of cardinality
 */
 
@@ -358,20 +690,25 @@ PG_FUNCTION_INFO_V1(intset_card);
 
 Datum
 intset_card(PG_FUNCTION_ARGS){
-	intset *set = (intset *)PG_GETARG_VARLENA_P(0);
-	int32 card=0,i;
-	if (VARDATA(set)[1] == '}'){PG_RETURN_INT32(card);}
-	for (i=0;i<(VARSIZE(set)-VARHDRSZ);i++){
-                if (VARDATA(set)[i] == ','){
-			card++;
-		}
+	run_reader r;
+	intset_run run;
+	int64 card=0;
+	instr_time start;
+	stats_begin(&start);
+	reader_init(&r, INTSET_GETARG_P(0));
+	while (next_run(&r, &run)){
+		card += run.hi - run.lo + 1;
 	}
-	card++;
-	PG_RETURN_INT32(card);
+	if (card > PG_INT32_MAX){
+		ereport(ERROR,(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),errmsg("CARDINALITY OUT OF RANGE FOR INTEGER")));
+	}
+	stats_end(INTSET_STAT_CARD, &start);
+	PG_RETURN_INT32((int32) card);
 }
 
 /*
   Function to determine if the intset contains value
+  The runs are scanned up to the first run past the value.
   Returns true or false.
 */
 
@@ -379,35 +716,25 @@ PG_FUNCTION_INFO_V1(intset_contains);
 
 Datum
 intset_contains(PG_FUNCTION_ARGS){
-        int32 num1 = PG_GETARG_INT32(0);
-		intset *set = (intset *)PG_GETARG_VARLENA_P(1);
-        int32 num2,i=0,j=0;
-        char buffer[MAXDIGITSIZE];
-        memset(buffer,'\0',MAXDIGITSIZE);
-        if( VARDATA(set)[1] == '}' ){ // empty set
-		PG_RETURN_BOOL(0);		
-	}
-	for (i=1;i<(VARSIZE(set)-VARHDRSZ);i++){
-                if (i<VARSIZE(set)-VARHDRSZ-1 && VARDATA(set)[i] != ',') {
-                        buffer[j] = VARDATA(set)[i];
-                        j++;
-                }
-                else{
-                        num2 = atol(buffer);
-                        if (num1 == num2 ) {
-                                PG_RETURN_BOOL(1);
-                        }
-                        memset(buffer,'\0',MAXDIGITSIZE);
-                        j=0;
-                }
+        int32 num = PG_GETARG_INT32(0);
+        run_reader r;
+        intset_run run;
+        bool found = false;
+        instr_time start;
+        stats_begin(&start);
+        reader_init(&r, INTSET_GETARG_P(1));
+        while (next_run(&r, &run) && num >= run.lo){
+                if (num <= run.hi) { found = true; break; }
         }
-        PG_RETURN_BOOL(0);
+        stats_end(INTSET_STAT_CONTAINS, &start);
+        PG_RETURN_BOOL(found);
 }
 
 
 /*
   Function determine if the first intset is a subset of the second
   i.e. all elements in a are in b
+  Runs are maximal, so each run of a must fit inside a single run of b.
 */
 
 
@@ -415,28 +742,36 @@ PG_FUNCTION_INFO_V1(intset_subset);
 
 Datum
 intset_subset(PG_FUNCTION_ARGS){
-        intset *set1 = (intset *)PG_GETARG_VARLENA_P(0);
-        intset *set2 = (intset *)PG_GETARG_VARLENA_P(1);
-        int32 num,i=0,j=0,current_index=1;
-        char buffer[MAXDIGITSIZE];
-        memset(buffer,'\0',MAXDIGITSIZE);
-        if (VARDATA(set1)[1] == '}') { // empty set
-		PG_RETURN_BOOL(1);
-	}	// empty set subset of all sets
-        for (i=1;i<(VARSIZE(set1)-VARHDRSZ);i++){
-                if (i<VARSIZE(set1)-VARHDRSZ-1 && VARDATA(set1)[i] != ',') {
-                        buffer[j] = VARDATA(set1)[i];
-                        j++;
-                }
-                else{
-                        num = atol(buffer);
-                        current_index = does_contain(num,set2,current_index);
-			if (current_index == 0){ PG_RETURN_BOOL(0); }
-                        memset(buffer,'\0',MAXDIGITSIZE);
-                        j=0;
-                }
+        run_reader r1, r2;
+        intset_run a, b;
+        bool has_b, subset = true;
+        instr_time start;
+        stats_begin(&start);
+        reader_init(&r1, INTSET_GETARG_P(0));
+        reader_init(&r2, INTSET_GETARG_P(1));
+        has_b = next_run(&r2, &b);
+        while (subset && next_run(&r1, &a)){
+                while (has_b && b.hi < a.lo) { has_b = next_run(&r2, &b); }
+                if (!has_b || a.lo < b.lo || a.hi > b.hi) { subset = false; }
+        }
+        stats_end(INTSET_STAT_SUBSET, &start);
+        PG_RETURN_BOOL(subset);
+}
+
+// helper function checks if two intsets hold the same runs
+// compares runs rather than bytes so older '{1,2,3}' values equal '{1-3}'
+static int does_equals(intset *set1, intset *set2){
+        run_reader r1, r2;
+        intset_run a, b;
+        bool has_a, has_b;
+        reader_init(&r1, set1);
+        reader_init(&r2, set2);
+        for (;;){
+                has_a = next_run(&r1, &a);
+                has_b = next_run(&r2, &b);
+                if (!has_a || !has_b) { return has_a == has_b; }
+                if (a.lo != b.lo || a.hi != b.hi) { return 0; }
         }
-        PG_RETURN_BOOL(1);
 }
 
 /*
@@ -448,16 +783,12 @@ PG_FUNCTION_INFO_V1(intset_equal);
 
 Datum
 intset_equal(PG_FUNCTION_ARGS){
-        intset *set1 = (intset *)PG_GETARG_VARLENA_P(0);
-        intset *set2 = (intset *)PG_GETARG_VARLENA_P(1);
-	int32 len1 = VARSIZE(set1), len2= VARSIZE(set2), i;
-	if (len1 != len2) { PG_RETURN_BOOL(0); }	
-	else {
-		for (i=1;i<len1-VARHDRSZ;i++){
-			if (VARDATA(set1)[i] != VARDATA(set2)[i]) {PG_RETURN_BOOL(0);}	
-		}
-	}
-	PG_RETURN_BOOL(1);
+        int equal;
+        instr_time start;
+        stats_begin(&start);
+        equal = does_equals(INTSET_GETARG_P(0),INTSET_GETARG_P(1));
+        stats_end(INTSET_STAT_EQUAL, &start);
+	PG_RETURN_BOOL(equal);
 }
 
 /*
@@ -470,12 +801,12 @@ PG_FUNCTION_INFO_V1(intset_not_equal);
 
 Datum
 intset_not_equal(PG_FUNCTION_ARGS){
-        intset *set1 = (intset *)PG_GETARG_VARLENA_P(0);
-        intset *set2 = (intset *)PG_GETARG_VARLENA_P(1);
-        int32 len1 = VARSIZE(set1), len2= VARSIZE(set2);
-        if (len1 != len2) { PG_RETURN_BOOL(1); }    
-      	if (does_equals(set1,set2) == 1){ PG_RETURN_BOOL(0);}
-        else { PG_RETURN_BOOL(1); }
+        int equal;
+        instr_time start;
+        stats_begin(&start);
+        equal = does_equals(INTSET_GETARG_P(0),INTSET_GETARG_P(1));
+        stats_end(INTSET_STAT_NOT_EQUAL, &start);
+      	PG_RETURN_BOOL(!equal);
 }
 
 
@@ -488,42 +819,18 @@ PG_FUNCTION_INFO_V1(intset_union);
 
 Datum
 intset_union(PG_FUNCTION_ARGS){
-        intset *set1 = (intset *)PG_GETARG_VARLENA_P(0);
-        intset *set2 = (intset *)PG_GETARG_VARLENA_P(1);
-        intset *new_set=(intset*)palloc(VARHDRSZ), *x, *y;
-        int32 i,j=0;
-        char buffer[MAXDIGITSIZE], *result;
+        intset *set1, *set2;
+        char *result;
+        instr_time start;
+        stats_begin(&start);
+        set1 = INTSET_GETARG_P(0);
+        set2 = INTSET_GETARG_P(1);
         // cases for empty set
-        if (VARDATA(set1)[1] == '}'){
-            result = intset_to_cstring(set2);
-			PG_RETURN_CSTRING(result);
-        }
-        else if (VARDATA(set2)[1] == '}'){
-			result = intset_to_cstring(set1);
-            PG_RETURN_CSTRING(result);
-        }
-	
-	memset(buffer,'\0',MAXDIGITSIZE);
-	if ( VARSIZE(set1) > VARSIZE(set2) ){ x = set1; y = set2;}
-	else { x = set2; y = set1;}
-	new_set = take_brackets(x);
-	for (i=1;i<VARSIZE(y)-VARHDRSZ;i++){
-		if (i<VARSIZE(y)-VARHDRSZ-1 && VARDATA(y)[i] !=','){
-			buffer[j]=VARDATA(y)[i];
-			j++;
-		}
-		else {
-			new_set = concat_inorder(new_set,buffer);
-			//printf("Concatenated buffer is %s \n", intset_to_cstring(new_set));
-			memset(buffer,'\0',MAXDIGITSIZE);
-			j=0;
-		}
-	}
-	//qsort(new_set, sizeof(new_set)/sizeof(*new_set), sizeof(*new_set), comp);
-	new_set = add_brackets(new_set);
-	result = intset_to_cstring(new_set);
-	//printf("results is %s \n", result);
-	PG_RETURN_CSTRING(result);
+        if (is_empty(set1)){ result = intset_to_cstring(set2); }
+        else if (is_empty(set2)){ result = intset_to_cstring(set1); }
+        else { result = run_merge(set1,set2,INTSET_UNION); }
+        stats_end(INTSET_STAT_UNION, &start);
+        PG_RETURN_CSTRING(result);
 }
 
 
@@ -537,44 +844,11 @@ PG_FUNCTION_INFO_V1(intset_inters);
 
 Datum
 intset_inters(PG_FUNCTION_ARGS){
-        intset *set1 = (intset *)PG_GETARG_VARLENA_P(0);
-        intset *set2 = (intset *)PG_GETARG_VARLENA_P(1);
-        intset *new_set=(intset*)palloc(VARHDRSZ), *x, *y; 
-        int32 i,j=0,current_index=1,new_index=0,loop_indicator=0;
-        char buffer[MAXDIGITSIZE], *result;
-        // set new_set as empty
-	SET_VARSIZE(new_set,VARHDRSZ);
-	// cases for empty set
-	if (VARDATA(set1)[1] == '}' || VARDATA(set2)[1] == '}'){
-                new_set = add_brackets(new_set);
-		result = intset_to_cstring(new_set);
-		PG_RETURN_CSTRING(result);
-        }
-	// otherwise start checking ints
-        memset(buffer,'\0',MAXDIGITSIZE);
-        if ( VARSIZE(set1) > VARSIZE(set2) ){ x = set1; y = set2;}
-        else { x = set2; y = set1;}
-	for (i=1;i<VARSIZE(y)-VARHDRSZ;i++){
-                if (i<VARSIZE(y)-VARHDRSZ-1 && VARDATA(y)[i] !=','){
-                        buffer[j]=VARDATA(y)[i];
-                        j++;
-                }
-                else {
-                        new_index = does_contain(atol(buffer),x,current_index);
-			if ( new_index != 0) {
-				// x contains the number
-				// update the largest number x has to loop from
-				current_index = new_index;
-				// concat to end of string
-				if ( loop_indicator == 0 ) { new_set = new_intset(new_set,buffer); loop_indicator++;}
-				else { new_set = concat_intset(new_set,buffer); }
-			}
-                        memset(buffer,'\0',MAXDIGITSIZE);
-                        j=0;
-                }
-        }
-	new_set = add_brackets(new_set);
-        result = intset_to_cstring(new_set);
+        char *result;
+        instr_time start;
+        stats_begin(&start);
+        result = run_merge(INTSET_GETARG_P(0),INTSET_GETARG_P(1),INTSET_INTERS);
+        stats_end(INTSET_STAT_INTERS, &start);
         PG_RETURN_CSTRING(result);
 }
 
@@ -590,12 +864,12 @@ PG_FUNCTION_INFO_V1(intset_dif);
 
 Datum
 intset_dif(PG_FUNCTION_ARGS){
-        intset *set1 = (intset *)PG_GETARG_VARLENA_P(0);
-        intset *set2 = (intset *)PG_GETARG_VARLENA_P(1);
-	intset *new = set_dif(set1,set2);
-	char *result;
-	result = intset_to_cstring(new);
-	PG_RETURN_CSTRING(result);
+        char *result;
+        instr_time start;
+        stats_begin(&start);
+        result = run_merge(INTSET_GETARG_P(0),INTSET_GETARG_P(1),INTSET_DIF);
+        stats_end(INTSET_STAT_DIF, &start);
+        PG_RETURN_CSTRING(result);
 }
 
 
@@ -609,43 +883,71 @@ PG_FUNCTION_INFO_V1(intset_disj);
 
 Datum
 intset_disj(PG_FUNCTION_ARGS){
-        intset *set1 = (intset *)PG_GETARG_VARLENA_P(0);
-        intset *set2 = (intset *)PG_GETARG_VARLENA_P(1);
-        intset *final,*new1, *new2, *x , *y;
-	char *result, buffer[MAXDIGITSIZE];
-        int32 i=1,j=0;
-	if (VARDATA(set1)[1] == '}') { final = set2; }
-	else if (VARDATA(set2)[1] == '}') { final = set1; } 
-	else {
-		new1 = set_dif(set1,set2);
-		new2 = set_dif(set2,set1);
-		if (VARDATA(new1)[1] == '}'){
-                	result = intset_to_cstring(new2);
-                	PG_RETURN_CSTRING(result);
-        	}
-        	else if (VARDATA(new2)[1] == '}'){
-                	result = intset_to_cstring(new1);
-                	PG_RETURN_CSTRING(result);
-        	}
-        	memset(buffer,'\0',MAXDIGITSIZE);
-        	if ( VARSIZE(new1) > VARSIZE(new2) ){ x = new1; y = new2;}
-        	else { x = new2; y = new1;}
-        	final = take_brackets(x);
-        	for (i=1;i<VARSIZE(y)-VARHDRSZ;i++){
-                	if (i<VARSIZE(y)-VARHDRSZ-1 && VARDATA(y)[i] !=','){
-                        	buffer[j]=VARDATA(y)[i];
-                        	j++;
-                	}
-                	else {
-                        	concat_intset(final,buffer);
-                       		memset(buffer,'\0',MAXDIGITSIZE);
-                        	j=0;
-                	}
-        	}
-        	final = add_brackets(final);
-        }
-	result = intset_to_cstring(final);
+        char *result;
+        instr_time start;
+        stats_begin(&start);
+        result = run_merge(INTSET_GETARG_P(0),INTSET_GETARG_P(1),INTSET_DISJ);
+        stats_end(INTSET_STAT_DISJ, &start);
         PG_RETURN_CSTRING(result);
 }
 
-    
+
+/*****************************************************************************
+ * Statistics functions
+ *****************************************************************************/
+
+
+/*
+  Returns one row per intset function with the counters collected in this
+  backend since it started or since the last intset_stats_reset().
+  Rows are returned even when intset.track_stats is off, they just stay zero.
+*/
+
+PG_FUNCTION_INFO_V1(intset_stats);
+
+Datum
+intset_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	TupleDesc tupdesc;
+	intset_counters *c;
+	Datum values[6];
+	bool nulls[6] = {false, false, false, false, false, false};
+	HeapTuple tuple;
+	if (SRF_IS_FIRSTCALL()){
+		MemoryContext oldcontext;
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE){
+			ereport(ERROR,(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),errmsg("intset_stats must be called in a context that accepts a record")));
+		}
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+		funcctx->max_calls = INTSET_NSTATS;
+		MemoryContextSwitchTo(oldcontext);
+	}
+	funcctx = SRF_PERCALL_SETUP();
+	if (funcctx->call_cntr >= funcctx->max_calls){ SRF_RETURN_DONE(funcctx); }
+
+	c = &intset_stats_data[funcctx->call_cntr];
+	values[0] = CStringGetTextDatum(intset_stat_names[funcctx->call_cntr]);
+	values[1] = Int64GetDatum(c->calls);
+	values[2] = Int64GetDatum(c->runs);
+	values[3] = Int64GetDatum(c->bytes_detoasted);
+	values[4] = Int64GetDatum(c->bytes_palloc);
+	values[5] = Float8GetDatum(INSTR_TIME_GET_MILLISEC(c->time));
+	tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+	SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+}
+
+/*
+  Clears every counter returned by intset_stats() in this backend.
+*/
+
+PG_FUNCTION_INFO_V1(intset_stats_reset);
+
+Datum
+intset_stats_reset(PG_FUNCTION_ARGS)
+{
+	memset(intset_stats_data, 0, sizeof(intset_stats_data));
+	PG_RETURN_VOID();
+}
@@ -0,0 +1,93 @@
+--
+-- Regression tests for the intset type
+--
+SET client_min_messages = warning;
+CREATE EXTENSION intset;
+RESET client_min_messages;
+
+-- input and canonical output
+SELECT '{}'::intset;
+SELECT '{ 1, 2 ,3}'::intset;
+SELECT '{3,1,2,2}'::intset;
+SELECT '{1,3}'::intset;
+SELECT '{1-1000,2000}'::intset;
+SELECT '{5,1-3,4}'::intset;
+SELECT '{-5--1,0}'::intset;
+SELECT '{1 - 4, 7}'::intset;
+SELECT '{2147483647,-2147483648}'::intset;
+
+-- bad input
+SELECT '1,2'::intset;
+SELECT '{a}'::intset;
+SELECT '{10-5}'::intset;
+SELECT '{99999999999}'::intset;
+
+-- range constructor
+SELECT intset_range(1, 1000000);
+SELECT intset_range(5, 1);
+SELECT @ intset_range(1, 1000000) AS card;
+
+-- cardinality and membership
+SELECT @ '{}'::intset AS card, @ '{1-10,20-30,40}'::intset AS card2;
+SELECT 5 <@ '{1-10,20-30,40}'::intset AS t, 15 <@ '{1-10,20-30,40}'::intset AS f;
+
+-- subset and equality
+SELECT '{5-8,22}'::intset @> '{1-10,20-30,40}'::intset AS t,
+       '{5-11}'::intset @> '{1-10,20-30,40}'::intset AS f,
+       '{}'::intset @> '{1}'::intset AS e;
+SELECT '{1,2,3,5}'::intset = '{1-3,5}'::intset AS t,
+       '{1-3}'::intset != '{1-4}'::intset AS t2;
+
+-- set operations
+SELECT '{1-10,20-30,40}'::intset || '{5-25,40,41}'::intset AS union_;
+SELECT '{1-10,20-30,40}'::intset && '{5-25,40,41}'::intset AS inters;
+SELECT '{1-10,20-30,40}'::intset - '{5-25,40,41}'::intset AS dif;
+SELECT '{1-10,20-30,40}'::intset !! '{5-25,40,41}'::intset AS disj;
+SELECT '{1-5}'::intset !! '{6-9}'::intset AS disj;
+SELECT '{}'::intset && '{1-5}'::intset AS inters;
+
+-- intset_add and intset_remove
+SELECT intset_remove(intset_add(intset_range(1, 10), 11), 5) AS s;
+SELECT @ intset_remove(intset_add(intset_range(1, 10), 11), 5) AS card;
+SELECT 5 <@ intset_add(intset_remove('{1-10}'::intset, 5), 5) AS t;
+SELECT intset_add(intset_remove('{1-10}'::intset, 5), 5) = '{1-10}'::intset AS t;
+SELECT intset_add('{}'::intset, -3) || '{1-2}'::intset AS union_;
+SELECT intset_add('{1,2,5}'::intset, 4), intset_add('{1,2,5}'::intset, 3), intset_add('{2}'::intset, 1);
+SELECT intset_remove('{1-3}'::intset, 1), intset_remove('{1-3}'::intset, 3), intset_remove('{1-3}'::intset, 7);
+
+-- changes kept in separate columns
+SELECT intset_apply('{1-10}', '{}', '{}') AS s;
+SELECT intset_apply('{1-10}', '{12,20-22}', '{1,5,21}') AS s;
+SELECT intset_apply('{}', '{3}', '{3}') AS s;
+SELECT intset_apply('{1-10}', '{}', '{1-10}') AS s;
+CREATE TABLE intset_append (id int, s intset, adds intset DEFAULT '{}', removes intset DEFAULT '{}');
+INSERT INTO intset_append (id, s) VALUES (1, '{1-1000}'), (2, '{5}');
+DO $$ BEGIN FOR i IN 1..100 LOOP
+  UPDATE intset_append SET adds = intset_add(adds, 1000 + i * 2), removes = intset_remove(removes, 1000 + i * 2) WHERE id = 1;
+END LOOP; END $$;
+UPDATE intset_append SET removes = intset_add(removes, 7), adds = intset_remove(adds, 7) WHERE id = 1;
+SELECT id, @ intset_apply(s, adds, removes) AS card, 1200 <@ intset_apply(s, adds, removes) AS t FROM intset_append ORDER BY id;
+SELECT intset_compact('intset_append', 's', 'adds', 'removes');
+SELECT id, @ s AS card, adds, removes FROM intset_append ORDER BY id;
+SELECT intset_compact('intset_append', 's', 'adds', 'removes');
+DROP TABLE intset_append;
+SELECT to_json(intset_add('{1}'::intset, 2)) AS j;
+SELECT row_to_json(t) FROM (SELECT intset_add('{1-3}'::intset, 5) AS s) t;
+
+-- statistics
+SET intset.track_stats = on;
+SELECT intset_stats_reset();
+SELECT intset_range(1, 5) || intset_range(3, 9) AS union_;
+SELECT func, calls FROM intset_stats() WHERE calls > 0 ORDER BY func;
+CREATE TABLE intset_toast (id int, s intset);
+INSERT INTO intset_toast VALUES (1, '{1-3}');
+INSERT INTO intset_toast SELECT 2, ('{' || string_agg(g::text, ',') || '}')::intset FROM generate_series(1, 40000, 2) g;
+SELECT intset_stats_reset();
+SELECT @ s AS card FROM intset_toast WHERE id = 1;
+SELECT bytes_detoasted FROM intset_stats() WHERE func = 'intset_card';
+SELECT @ s AS card FROM intset_toast WHERE id = 2;
+SELECT bytes_detoasted > 0 AS detoasted, bytes_palloc >= bytes_detoasted AS palloc FROM intset_stats() WHERE func = 'intset_card';
+DROP TABLE intset_toast;
+SELECT intset_stats_reset();
+SELECT count(*) FROM intset_stats() WHERE calls > 0;
+RESET intset.track_stats;